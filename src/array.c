@@ -64,6 +64,17 @@ PMOD_EXPORT void dont_accept_unfinished_type_fields (void *orig)
 #endif
 
 
+/* Freed small arrays are kept on free lists per size, so that short
+ * lived temporaries can be reused without a round trip to malloc.
+ * Mappings and objects already get this from their block allocators.
+ */
+#ifndef DEBUG_MALLOC
+#define ARRAY_CACHE_SIZES	8
+#define ARRAY_CACHE_MAX		64
+static struct array *array_cache[ARRAY_CACHE_SIZES];
+static int array_cache_count[ARRAY_CACHE_SIZES];
+#endif
+
 /**
  * Allocate an array. This might be changed in the future to allocate
  * linked lists or something. The new array has zero references.
@@ -94,11 +105,20 @@ PMOD_EXPORT struct array *real_allocate_array(ptrdiff_t size,
     Pike_error("Too large array (size %ld exceeds %ld).\n",
 	       (long)(size+extra_space-1),
 	       (long)((LONG_MAX-sizeof(struct array))/sizeof(struct svalue)) );
-  v=malloc(sizeof(struct array)+
-           (size+extra_space-1)*sizeof(struct svalue));
-  if(!v)
-    Pike_error(msg_out_of_mem_2, sizeof(struct array)+
-	       (size+extra_space-1)*sizeof(struct svalue));
+#ifdef ARRAY_CACHE_SIZES
+  if ((size+extra_space <= ARRAY_CACHE_SIZES) &&
+      (v = array_cache[size+extra_space-1])) {
+    array_cache[size+extra_space-1] = v->next;
+    array_cache_count[size+extra_space-1]--;
+  } else
+#endif
+  {
+    v=malloc(sizeof(struct array)+
+             (size+extra_space-1)*sizeof(struct svalue));
+    if(!v)
+      Pike_error(msg_out_of_mem_2, sizeof(struct array)+
+                 (size+extra_space-1)*sizeof(struct svalue));
+  }
 
   GC_ALLOC(v);
 
@@ -135,11 +155,37 @@ static void array_free_no_free(struct array *v)
 {
   DOUBLEUNLINK (first_array, v);
 
-  free(v);
+#ifdef ARRAY_CACHE_SIZES
+  if ((v->malloced_size > 0) && (v->malloced_size <= ARRAY_CACHE_SIZES) &&
+      (array_cache_count[v->malloced_size-1] < ARRAY_CACHE_MAX)) {
+    v->next = array_cache[v->malloced_size-1];
+    array_cache[v->malloced_size-1] = v;
+    array_cache_count[v->malloced_size-1]++;
+  } else
+#endif
+    free(v);
 
   GC_FREE(v);
 }
 
+/**
+ * Free the arrays kept for reuse by real_allocate_array.
+ */
+void free_all_array_blocks(void)
+{
+#ifdef ARRAY_CACHE_SIZES
+  int e;
+  for (e = 0; e < ARRAY_CACHE_SIZES; e++) {
+    struct array *v;
+    while ((v = array_cache[e])) {
+      array_cache[e] = v->next;
+      free(v);
+    }
+    array_cache_count[e] = 0;
+  }
+#endif
+}
+
 /**
  * Free an array. Call this when the array has zero references.
  * @param v The array to free.
@@ -1265,10 +1311,132 @@ static int alpha_int_svalue_cmpfun(const struct svalue *a, const struct svalue *
 #undef TYPE
 #undef ID
 
+/* Arrays of only ints or only floats at least this large are radix
+ * sorted. */
+#define RADIX_SORT_THRESHOLD	256
+
+/* The float keys are built from a double, which would lose precision
+ * with a long double FLOAT_TYPE. Such floats use the comparison sort. */
+#if SIZEOF_FLOAT_TYPE <= 8
+#define RADIX_SORT_TYPES	(BIT_INT | BIT_FLOAT)
+#else
+#define RADIX_SORT_TYPES	BIT_INT
+#endif
+
+/* Map an int or float to an unsigned 64 bit key with the same order. */
+static inline unsigned INT64 radix_key(const struct svalue *s)
+{
+  if (TYPEOF(*s) == T_INT)
+    return ((unsigned INT64)(INT64)s->u.integer) ^ ((unsigned INT64)1 << 63);
+#if SIZEOF_FLOAT_TYPE <= 8
+  {
+    double d = (double)s->u.float_number;
+    unsigned INT64 bits;
+    memcpy(&bits, &d, sizeof(bits));
+    if (bits >> 63) return ~bits;
+    return bits ^ ((unsigned INT64)1 << 63);
+  }
+#else
+  return 0;
+#endif
+}
+
+/* LSD radix sort on the svalues themselves. All elements must be
+ * ints, or all must be floats (see RADIX_SORT_TYPES). Bytes that are
+ * the same in all keys (eg the high bytes of small ints) are skipped.
+ * The svalues are only moved around, so no references change and
+ * nothing can throw once the buffer has been allocated.
+ */
+static void radix_sort_svalues(struct svalue *svals, ptrdiff_t n)
+{
+  ptrdiff_t counts[8][256];
+  struct svalue *src = svals, *dst, *buf;
+  ptrdiff_t e;
+  int b;
+
+  buf = xalloc(n * sizeof(struct svalue));
+  dst = buf;
+
+  memset(counts, 0, sizeof(counts));
+  for (e = 0; e < n; e++) {
+    unsigned INT64 k = radix_key(svals + e);
+    for (b = 0; b < 8; b++)
+      counts[b][(k >> (b*8)) & 0xff]++;
+  }
+
+  for (b = 0; b < 8; b++) {
+    ptrdiff_t *cnt = counts[b];
+    ptrdiff_t pos = 0;
+    int d;
+
+    /* Skip the pass if every key has the same byte here. */
+    if (cnt[(radix_key(src) >> (b*8)) & 0xff] == n) continue;
+
+    for (d = 0; d < 256; d++) {
+      ptrdiff_t c = cnt[d];
+      cnt[d] = pos;
+      pos += c;
+    }
+    for (e = 0; e < n; e++) {
+      dst[cnt[(radix_key(src + e) >> (b*8)) & 0xff]++] = src[e];
+    }
+    {
+      struct svalue *t = src;
+      src = dst;
+      dst = t;
+    }
+  }
+
+  if (src != svals) memcpy(svals, src, n * sizeof(struct svalue));
+  free(buf);
+}
+
+/* Returns 1 if the array is in ascending order, or -1 if it is in
+ * strictly descending order. Both are common in practice and much
+ * cheaper to detect than to sort. */
+static int sorted_direction(struct svalue *svals, ptrdiff_t n)
+{
+  ptrdiff_t e;
+  for (e = 1; e < n; e++)
+    if ((alpha_svalue_cmpfun(svals + e - 1, svals + e) & ~CMPFUN_UNORDERED)
+	> 0)
+      break;
+  if (e == n) return 1;
+  if (e > 1) return 0;
+  for (e = 1; e < n; e++)
+    if ((alpha_svalue_cmpfun(svals + e - 1, svals + e) & ~CMPFUN_UNORDERED)
+	<= 0)
+      return 0;
+  return -1;
+}
+
+static void reverse_svalues(struct svalue *svals, ptrdiff_t n)
+{
+  struct svalue *a = svals, *b = svals + n - 1;
+  while (a < b) {
+    struct svalue tmp = *a;
+    *a++ = *b;
+    *b-- = tmp;
+  }
+}
+
 /** This sort is unstable. */
 PMOD_EXPORT void sort_array_destructively(struct array *v)
 {
   if(!v->size) return;
+  if (((v->type_field == BIT_INT) || (v->type_field == BIT_FLOAT)) &&
+      (v->type_field & RADIX_SORT_TYPES) &&
+      (v->size >= RADIX_SORT_THRESHOLD)) {
+    radix_sort_svalues(ITEM(v), v->size);
+    return;
+  }
+  switch (sorted_direction(ITEM(v), v->size)) {
+  case 1:
+    return;
+  case -1:
+    reverse_svalues(ITEM(v), v->size);
+    return;
+  }
   if (v->type_field == BIT_INT) {
     low_sort_int_svalues(ITEM(v), ITEM(v)+v->size-1);
   } else {
@@ -1276,36 +1444,120 @@ PMOD_EXPORT void sort_array_destructively(struct array *v)
   }
 }
 
-#define SORT_BY_INDEX
-#define EXTRA_LOCALS int cmpfun_res;
-#define CMP(X,Y) ((cmpfun_res =						\
-		     (alpha_svalue_cmpfun(svals + X, svals + Y) &	\
-		      ~CMPFUN_UNORDERED)) ?				\
-		  cmpfun_res : pos[X] - pos[Y])
-#define SWAP(X,Y) {							\
-  {struct svalue tmp = svals[X]; svals[X] = svals[Y]; svals[Y] = tmp;}	\
-  {int tmp = pos[X]; pos[X] = pos[Y]; pos[Y] = tmp;}			\
+/* Runs shorter than this are extended with insertion sort before
+ * merging. */
+#define MIN_MERGE_RUN	16
+
+#define STABLE_CMP(X, Y)						\
+  (alpha_svalue_cmpfun(svals + (X), svals + (Y)) & ~CMPFUN_UNORDERED)
+
+/* Stable natural merge sort of the indices in order[] by the svalues
+ * they refer to. Ascending and strictly descending runs already in
+ * the input are used as is, so presorted data sorts in linear time,
+ * and merging needs fewer comparisons than quicksort, which matters
+ * when they call lfuns.
+ *
+ * Only the index arrays are permuted, so an error thrown by a
+ * comparison leaves svals untouched.
+ */
+static void low_stable_sort_svalues(struct svalue *svals, INT32 *order,
+				    INT32 *tmp, INT32 n)
+{
+  INT32 *runs;
+  INT32 num_runs = 0;
+  INT32 start = 0;
+  ONERROR err;
+
+  runs = xalloc((n / MIN_MERGE_RUN + 2) * sizeof(INT32));
+  SET_ONERROR(err, free, runs);
+
+  /* Split into runs of at least MIN_MERGE_RUN elements. */
+  while (start < n) {
+    INT32 end = start + 1;
+    INT32 lim;
+
+    if (end < n) {
+      if (STABLE_CMP(order[start], order[end]) > 0) {
+	/* Strictly descending, so reversing it keeps it stable. */
+	while ((end + 1 < n) &&
+	       (STABLE_CMP(order[end], order[end + 1]) > 0))
+	  end++;
+	{
+	  INT32 a = start, b = end;
+	  while (a < b) {
+	    INT32 t = order[a];
+	    order[a++] = order[b];
+	    order[b--] = t;
+	  }
+	}
+      } else {
+	while ((end + 1 < n) &&
+	       (STABLE_CMP(order[end], order[end + 1]) <= 0))
+	  end++;
+      }
+      end++;
+    }
+
+    lim = start + MIN_MERGE_RUN;
+    if (lim > n) lim = n;
+    for (; end < lim; end++) {
+      /* Binary insertion, after any equal elements. */
+      INT32 x = order[end];
+      INT32 lo = start, hi = end;
+      while (lo < hi) {
+	INT32 mid = lo + ((hi - lo) >> 1);
+	if (STABLE_CMP(x, order[mid]) < 0)
+	  hi = mid;
+	else
+	  lo = mid + 1;
+      }
+      memmove(order + lo + 1, order + lo, (end - lo) * sizeof(INT32));
+      order[lo] = x;
+    }
+
+    runs[num_runs++] = start;
+    start = end;
+  }
+  runs[num_runs] = n;
+
+  /* Merge adjacent runs pairwise until only one is left. */
+  while (num_runs > 1) {
+    INT32 r, w = 0;
+    for (r = 0; r + 1 < num_runs; r += 2) {
+      INT32 lo = runs[r], mid = runs[r + 1], hi = runs[r + 2];
+      runs[w++] = lo;
+      if (STABLE_CMP(order[mid - 1], order[mid]) > 0) {
+	INT32 a = 0, b = mid, o = lo;
+	INT32 alen = mid - lo;
+	memcpy(tmp, order + lo, alen * sizeof(INT32));
+	while ((a < alen) && (b < hi)) {
+	  if (STABLE_CMP(order[b], tmp[a]) < 0)
+	    order[o++] = order[b++];
+	  else
+	    order[o++] = tmp[a++];
+	}
+	if (a < alen)
+	  memcpy(order + o, tmp + a, (alen - a) * sizeof(INT32));
+      }
+    }
+    if (r < num_runs) runs[w++] = runs[r];
+    runs[w] = n;
+    num_runs = w;
+  }
+
+  CALL_AND_UNSET_ONERROR(err);
 }
-#define TYPE struct svalue
-#define ID low_stable_sort_svalues
-#define EXTRA_ARGS , struct svalue *svals, INT32 *pos, int size
-#define XARGS , svals, pos, size
-#include "fsort_template.h"
-#undef SORT_BY_INDEX
-#undef EXTRA_LOCALS
-#undef CMP
-#undef SWAP
-#undef TYPE
-#undef ID
-#undef EXTRA_ARGS
-#undef XARGS
+
+#undef STABLE_CMP
 
 /** This sort is stable. The return value is like the one from
  * get_alpha_order. */
 PMOD_EXPORT INT32 *stable_sort_array_destructively(struct array *v)
 {
   INT32 *current_order;
-  ONERROR tmp;
+  struct svalue *buf;
+  struct svalue *svals = ITEM(v);
+  ONERROR tmp, tmp2;
   int e;
 
   if(!v->size) return NULL;
@@ -1315,7 +1567,17 @@ PMOD_EXPORT INT32 *stable_sort_array_destructively(struct array *v)
   SET_ONERROR(tmp, free, current_order);
   for(e=0; e<v->size; e++) current_order[e]=e;
 
-  low_stable_sort_svalues (0, v->size - 1, ITEM (v), current_order, v->size);
+  /* Used as merge space while sorting, and then for applying the
+   * permutation to the svalues. */
+  buf = xalloc(v->size * sizeof(struct svalue));
+  SET_ONERROR(tmp2, free, buf);
+
+  low_stable_sort_svalues(svals, current_order, (INT32 *)buf, v->size);
+
+  memcpy(buf, svals, v->size * sizeof(struct svalue));
+  for(e=0; e<v->size; e++) svals[e] = buf[current_order[e]];
+
+  CALL_AND_UNSET_ONERROR(tmp2);
 
   UNSET_ONERROR (tmp);
   return current_order;
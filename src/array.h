@@ -211,6 +211,7 @@ void debug_dump_type_field(TYPE_FIELD t);
 void debug_dump_array(struct array *a);
 #endif
 void count_memory_in_arrays(size_t *num_, size_t *size_);
+void free_all_array_blocks(void);
 PMOD_EXPORT struct array *explode_array(struct array *a, struct array *b);
 PMOD_EXPORT struct array *implode_array(struct array *a, struct array *b);
 
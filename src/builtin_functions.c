@@ -45,6 +45,11 @@
 #include "pike_compiler.h"
 #include "port.h"
 #include "siphash24.h"
+#include "bitvector.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include <errno.h>
 
@@ -4356,6 +4361,56 @@ void compile_replace_many(struct replace_many_context *ctx,
     }
   }
   ctx->num = num;
+
+  ctx->num_first_chars = 0;
+  for(e=0;e<num;e++)
+  {
+    p_wchar2 x = index_shared_string(ctx->v[e].ind, 0);
+    int i;
+    if ((x < 0) || (x > 255)) continue;	/* Never matches 8-bit strings. */
+    for (i = 0; i < ctx->num_first_chars; i++)
+      if (ctx->first_chars[i] == x) break;
+    if (i < ctx->num_first_chars) continue;
+    if (i == NELEM(ctx->first_chars)) {
+      ctx->num_first_chars = -1;
+      break;
+    }
+    ctx->first_chars[ctx->num_first_chars++] = x;
+  }
+}
+
+/* Returns the number of leading characters in ss that can't be the
+ * start of a match.
+ */
+static ptrdiff_t replace_many_skip0(struct replace_many_context *ctx,
+				    p_wchar0 *ss, ptrdiff_t len)
+{
+  ptrdiff_t i = 0;
+
+  if (!ctx->num_first_chars) return len;
+
+#ifdef __SSE2__
+  if (ctx->num_first_chars > 0) {
+    int n = ctx->num_first_chars;
+    __m128i c0 = _mm_set1_epi8(ctx->first_chars[0]);
+    __m128i c1 = _mm_set1_epi8(ctx->first_chars[n > 1 ? 1 : 0]);
+    __m128i c2 = _mm_set1_epi8(ctx->first_chars[n > 2 ? 2 : 0]);
+    __m128i c3 = _mm_set1_epi8(ctx->first_chars[n > 3 ? 3 : 0]);
+
+    for (; i + 16 <= len; i += 16) {
+      __m128i v = _mm_loadu_si128((__m128i *)(ss + i));
+      unsigned INT32 mask =
+	_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, c0),
+						    _mm_cmpeq_epi8(v, c1)),
+				       _mm_or_si128(_mm_cmpeq_epi8(v, c2),
+						    _mm_cmpeq_epi8(v, c3))));
+      if (mask) return i + ctz32(mask);
+    }
+  }
+#endif
+
+  while ((i < len) && !ctx->set_end[ss[i]]) i++;
+  return i;
 }
 
 struct pike_string *execute_replace_many(struct replace_many_context *ctx,
@@ -4381,6 +4436,7 @@ struct pike_string *execute_replace_many(struct replace_many_context *ctx,
 	  INT32 a, b;					\
 	  p_wchar2 ch;					\
 							\
+	  OPT_SKIP_CHARS(ss);				\
 	  ch = ss[s];					\
 	  if(OPT_IS_CHAR(ch)) {				\
 	    b = ctx->set_end[ch];			\
@@ -4441,11 +4497,21 @@ struct pike_string *execute_replace_many(struct replace_many_context *ctx,
       }							\
     break
 #define OPT_IS_CHAR(X)	1
+#define OPT_SKIP_CHARS(SS)				\
+    if (!ctx->empty_repl) {				\
+      ptrdiff_t skip = replace_many_skip0(ctx, SS + s, length);	\
+      s += skip;					\
+      length -= skip;					\
+      if (!length) break;				\
+    }
     CASE(0);
+#undef OPT_SKIP_CHARS
 #undef OPT_IS_CHAR
 #define OPT_IS_CHAR(X)	((size_t) (X) < NELEM(ctx->set_end))
+#define OPT_SKIP_CHARS(SS)
     CASE(1);
     CASE(2);
+#undef OPT_SKIP_CHARS
 #undef OPT_IS_CHAR
   }
 
@@ -8337,6 +8403,80 @@ PMOD_EXPORT void f_transpose(INT32 args)
   return;
 }
 
+/*! @decl mixed array_sum(array a)
+ *!
+ *!   Sum the elements of @[a] using @[`+()]. The sum of the empty
+ *!   array is @expr{0@}.
+ *!
+ *!   Arrays containing only ints and floats are summed directly,
+ *!   without pushing the elements on the stack.
+ *!
+ *! @seealso
+ *!   @[Array.sum()]
+ */
+PMOD_EXPORT void f_array_sum(INT32 args)
+{
+  struct array *a;
+  TYPE_FIELD types;
+  INT32 e;
+
+  if (args!=1)
+    SIMPLE_WRONG_NUM_ARGS_ERROR("array_sum", 1);
+
+  if (TYPEOF(Pike_sp[-args]) != T_ARRAY)
+    SIMPLE_ARG_TYPE_ERROR("array_sum", 1, "array");
+
+  a = Pike_sp[-1].u.array;
+  if (!a->size) {
+    pop_stack();
+    push_int(0);
+    return;
+  }
+
+  types = array_fix_type_field(a);
+
+  if (types == BIT_INT) {
+    INT_TYPE sum = 0;
+    for (e = 0; e < a->size; e++) {
+      if (DO_INT_TYPE_ADD_OVERFLOW(sum, ITEM(a)[e].u.integer, &sum))
+	break;
+    }
+    if (e == a->size) {
+      pop_stack();
+      push_int(sum);
+      return;
+    }
+    /* Overflow. Let `+() deal with the bignums. */
+  } else if (!(types & ~(BIT_INT|BIT_FLOAT))) {
+    /* Same as `+() on a mix of ints and floats. */
+    double sum = 0.0;
+    for (e = 0; e < a->size; e++) {
+      struct svalue *s = ITEM(a) + e;
+      if (TYPEOF(*s) == T_FLOAT)
+	sum += s->u.float_number;
+      else
+	sum += (double)s->u.integer;
+    }
+    pop_stack();
+    push_float((FLOAT_TYPE)sum);
+    return;
+  }
+
+  /* Generic case. Add the elements in chunks to bound the stack use. */
+  push_svalue(ITEM(a));
+  for (e = 1; e < a->size;) {
+    INT32 n = a->size - e;
+    INT32 i;
+    if (n > 999) n = 999;
+    check_stack(n);
+    for (i = 0; i < n; i++)
+      push_svalue(ITEM(a) + e + i);
+    e += n;
+    f_add(n + 1);
+  }
+  stack_pop_keep_top();
+}
+
 /*! @endmodule
  */
 
@@ -9670,6 +9810,10 @@ void init_builtin_efuns(void)
 		tFunc(tArr(tSetvar(0,tMix)),tArr(tVar(0))), 0,
 		OPT_TRY_OPTIMIZE);
 
+  ADD_FUNCTION2("array_sum",f_array_sum,
+		tFunc(tArr(tSetvar(0,tMix)),tOr(tVar(0),tInt0)), 0,
+		OPT_TRY_OPTIMIZE);
+
   /* function(string:string)|function(int:int) */
   ADD_EFUN("upper_case",f_upper_case,
 	   tOr(tFunc(tStr,tStr),tFunc(tInt,tInt)),OPT_TRY_OPTIMIZE);
@@ -9795,6 +9939,10 @@ void init_builtin_efuns(void)
   ADD_EFUN("encode_value_canonic", f_encode_value_canonic,
 	   tFunc(tMix tOr(tVoid,tObj),tStr8), OPT_TRY_OPTIMIZE);
 
+  ADD_FUNCTION2("encode_value_to", f_encode_value_to,
+		tFunc(tMix tFunc(tStr8,tMix) tOr(tVoid,tObj),tInt), 0,
+		OPT_SIDE_EFFECT);
+
   /* function(string,void|object:mixed) */
   ADD_EFUN("decode_value", f_decode_value,
 	   tFunc(tStr tOr(tVoid,tObj),tMix), OPT_TRY_OPTIMIZE);
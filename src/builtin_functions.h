@@ -42,6 +42,10 @@ struct replace_many_context
   int other_start;
   int num;
   int flags;
+  /* The distinct first characters of the from strings, if they are
+   * at most four and all 8-bit. */
+  int num_first_chars;
+  unsigned char first_chars[4];
 };
 
 PMOD_EXPORT struct object *get_val_true(void);
@@ -141,6 +145,7 @@ PMOD_EXPORT void f_uniq_array(INT32 args);
 PMOD_EXPORT void f_splice(INT32 args);
 PMOD_EXPORT void f_everynth(INT32 args);
 PMOD_EXPORT void f_transpose(INT32 args);
+PMOD_EXPORT void f_array_sum(INT32 args);
 PMOD_EXPORT void f__reset_dmalloc(INT32 args);
 PMOD_EXPORT void f__dmalloc_set_name(INT32 args);
 PMOD_EXPORT void f__list_open_fds(INT32 args);
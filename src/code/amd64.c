@@ -523,6 +523,29 @@ static void mov_reg_mem128( enum amd64_reg from_reg, enum amd64_reg to_reg, int
   offset_modrm_sib( offset, from_reg, to_reg );
 }
 
+#if SIZEOF_FLOAT_TYPE == 8 || SIZEOF_FLOAT_TYPE == 4
+#define AMD64_SSE_FLOATS
+
+#define SSE_MOV_MEM_REG	0x10	/* MOVSD/MOVSS xmm,m */
+#define SSE_MOV_REG_MEM	0x11	/* MOVSD/MOVSS m,xmm */
+#define SSE_ADD_MEM_REG	0x58	/* ADDSD/ADDSS xmm,m */
+
+/* Scalar SSE operation between xmm_reg and a FLOAT_TYPE in memory. */
+static void sse_float_mem_reg( int op, enum amd64_reg mem_reg, int offset,
+                               enum amd64_reg xmm_reg )
+{
+#if SIZEOF_FLOAT_TYPE == 8
+  opcode( 0xf2 );
+#else
+  opcode( 0xf3 );
+#endif
+  rex(0,xmm_reg,0,mem_reg);
+  opcode( 0x0f );
+  opcode( op );
+  offset_modrm_sib( offset, xmm_reg, mem_reg );
+}
+#endif
+
 static void low_set_if_cond(unsigned char subop, enum amd64_reg reg)
 {
   rex( 0, 0, 0, reg );
@@ -2248,6 +2271,10 @@ void ins_f_byte(unsigned int b)
   LABEL_C;
     }
     return;
+  case F_ADD:
+    /* The int+int check is only a few instructions, and untyped
+       loop counters and accumulators are common enough that it is
+       worth trying before calling f_add. */
   case F_ADD_INTS:
     {
       ins_debug_instr_prologue(b, 0, 0);
@@ -2516,14 +2543,33 @@ void ins_f_byte(unsigned int b)
       LABEL_D;
     }
     return;
-  case F_ADD:
+#ifdef AMD64_SSE_FLOATS
+  case F_ADD_FLOATS:
     {
-    addr = f_add;
-    update_arg1(2);
-    amd64_call_c_opcode(addr, flags);
-    amd64_load_sp_reg();
+      LABELS();
+      ins_debug_instr_prologue(b, 0, 0);
+      amd64_load_sp_reg();
+      mov_mem8_reg( sp_reg, SVAL(-1).type, P_REG_RAX );
+      mov_mem8_reg( sp_reg, SVAL(-2).type, P_REG_RCX );
+      cmp_reg32_imm( P_REG_RAX, PIKE_T_FLOAT );
+      jne( &label_A );
+      cmp_reg32_imm( P_REG_RCX, PIKE_T_FLOAT );
+      jne( &label_A );
+      /* Both are floats, add them without leaving the generated code. */
+      sse_float_mem_reg( SSE_MOV_MEM_REG, sp_reg, SVAL(-2).value, P_REG_XMM0 );
+      sse_float_mem_reg( SSE_ADD_MEM_REG, sp_reg, SVAL(-1).value, P_REG_XMM0 );
+      sse_float_mem_reg( SSE_MOV_REG_MEM, sp_reg, SVAL(-2).value, P_REG_XMM0 );
+      amd64_add_sp( -1 );
+      jmp( &label_B );
+
+      LABEL_A;
+      update_arg1( 2 );
+      amd64_call_c_opcode( f_add, I_UPDATE_SP );
+      amd64_load_sp_reg();
+      LABEL_B;
     }
     return;
+#endif
 
   case F_SUBTRACT:
     {
@@ -162,6 +162,12 @@ struct encode_data
    * to a thing not yet encoded. */
   struct array *delayed;
   struct byte_buffer buf;
+  /* When set, the encoded data is passed to this function in chunks
+   * instead of being accumulated in buf. */
+  struct svalue *sink;
+  INT64 flushed;
+  /* Nonzero while there is a pending back patch in buf. */
+  int no_flush;
 #ifdef ENCODE_DEBUG
   int debug, depth;
 #endif
@@ -180,6 +186,37 @@ static struct object *encoder_codec (struct encode_data *data)
 
 static void encode_value2(struct svalue *val, struct encode_data *data, int force_encode);
 
+/* Chunk size for encode_value_to(). */
+#define ENCODE_FLUSH_SIZE	(64*1024)
+
+/* Pass the contents of the buffer to the sink, if any. Returns 1 if
+ * the buffer is empty afterwards. */
+static int encode_flush(struct encode_data *data)
+{
+  size_t len;
+  if (!data->sink || data->no_flush) return 0;
+  len = buffer_content_length(&data->buf);
+  if (len) {
+    push_string(make_shared_binary_string(buffer_ptr(&data->buf), len));
+    buffer_clear(&data->buf);
+    data->flushed += len;
+    apply_svalue(data->sink, 1);
+    pop_stack();
+  }
+  return 1;
+}
+
+/* Pass a large string directly to the sink. The buffer must have
+ * been flushed. */
+static void encode_sink_string(struct encode_data *data,
+			       struct pike_string *s)
+{
+  ref_push_string(s);
+  data->flushed += s->len;
+  apply_svalue(data->sink, 1);
+  pop_stack();
+}
+
 #define addstr(s, l) buffer_memcpy(&(data->buf), (s), (l))
 #define addchar(t)   buffer_add_char(&(data->buf), (char)(t))
 #define addchar_unsafe(t)       buffer_add_char_unsafe(&(data->buf), t)
@@ -218,7 +255,11 @@ static void encode_value2(struct svalue *val, struct encode_data *data, int forc
     ENCODE_DATA(__str);                                 \
   }else{                                                \
     code_entry(TAG_STRING, __str->len, data);           \
-    addstr((char *)(__str->str),__str->len);            \
+    if ((__str->len >= ENCODE_FLUSH_SIZE) &&            \
+        encode_flush(data))                             \
+      encode_sink_string(data, (struct pike_string *)__str); \
+    else                                                \
+      addstr((char *)(__str->str),__str->len);          \
   }                                                     \
 }while(0)
 
@@ -475,6 +516,9 @@ static void encode_value2(struct svalue *val, struct encode_data *data, int forc
   data->depth += 2;
 #endif
 
+  if (buffer_content_length(&data->buf) >= ENCODE_FLUSH_SIZE)
+    encode_flush(data);
+
   if((TYPEOF(*val) == T_OBJECT ||
       (TYPEOF(*val) == T_FUNCTION && SUBTYPEOF(*val) != FUNCTION_BUILTIN)) &&
      !val->u.object->prog)
@@ -817,7 +861,7 @@ static void encode_value2(struct svalue *val, struct encode_data *data, int forc
 	case T_INT:
 	  if(SUBTYPEOF(Pike_sp[-1]) == NUMBER_UNDEFINED)
 	  {
-	    int to_change = buffer_content_length(&data->buf);
+	    int to_change;
 	    struct svalue tmp = entry_id;
 
 	    EDB(5,fprintf(stderr, "%*s(UNDEFINED)\n", data->depth, ""));
@@ -842,8 +886,11 @@ static void encode_value2(struct svalue *val, struct encode_data *data, int forc
 	    f_object_program(1);
 
 	    /* Code the program */
+	    to_change = buffer_content_length(&data->buf);
+	    data->no_flush++;
 	    code_entry(TAG_OBJECT, 3,data);
 	    encode_value2(Pike_sp-1, data, 1);
+	    data->no_flush--;
 	    pop_stack();
 
 	    push_svalue(val);
@@ -1758,6 +1805,9 @@ void f_encode_value(INT32 args)
 
   buffer_init(&data->buf);
   data->canonic = 0;
+  data->sink = NULL;
+  data->flushed = 0;
+  data->no_flush = 0;
   data->encoded=allocate_mapping(128);
   data->encoded->data->flags |= MAPPING_FLAG_NO_SHRINK;
   data->delayed = allocate_array (0);
@@ -1836,6 +1886,9 @@ void f_encode_value_canonic(INT32 args)
 
   buffer_init(&data->buf);
   data->canonic = 1;
+  data->sink = NULL;
+  data->flushed = 0;
+  data->no_flush = 0;
   data->encoded=allocate_mapping(128);
   data->delayed = allocate_array (0);
   SET_SVAL(data->counter, T_INT, NUMBER_NUMBER, integer, COUNTER_START);
@@ -1874,6 +1927,94 @@ void f_encode_value_canonic(INT32 args)
   push_string(buffer_finish_pike_string(&data->buf));
 }
 
+/*! @module Pike
+ */
+
+/*! @decl int encode_value_to(mixed value, @
+ *!                           function(string(8bit):mixed) write, @
+ *!                           Codec|void codec)
+ *!
+ *! Code a value like @[encode_value()], but pass the result to
+ *! @[write] in chunks instead of returning it as a single string.
+ *!
+ *! The concatenation of the strings passed to @[write] is the same
+ *! as the string @[encode_value()] would have returned, so it can be
+ *! decoded with @[decode_value()]. @[write] must consume all of each
+ *! string it's passed, eg the @expr{add@} function of a
+ *! @[Stdio.Buffer].
+ *!
+ *! This avoids having to keep the full encoded value in memory,
+ *! which matters when encoding very large values.
+ *!
+ *! @returns
+ *!   Returns the total number of bytes passed to @[write].
+ *!
+ *! @note
+ *!   The return value of @[write] is ignored, so a function that may
+ *!   write only part of the data, like @expr{write@} in a nonblocking
+ *!   @[Stdio.File], can't be used directly. Errors thrown by
+ *!   @[write] abort the encoding.
+ *!
+ *! @seealso
+ *!   @[encode_value()], @[decode_value()]
+ */
+void f_encode_value_to(INT32 args)
+{
+  ONERROR tmp;
+  struct encode_data d, *data;
+  int i;
+  data=&d;
+
+  check_all_args("encode_value_to", args,
+		 BIT_MIXED,
+		 BIT_FUNCTION | BIT_OBJECT | BIT_PROGRAM,
+		 BIT_VOID | BIT_OBJECT | BIT_ZERO,
+		 0);
+
+  buffer_init(&data->buf);
+  data->canonic = 0;
+  data->sink = Pike_sp+1-args;
+  data->flushed = 0;
+  data->no_flush = 0;
+  data->encoded=allocate_mapping(128);
+  data->encoded->data->flags |= MAPPING_FLAG_NO_SHRINK;
+  data->delayed = allocate_array (0);
+  SET_SVAL(data->counter, T_INT, NUMBER_NUMBER, integer, COUNTER_START);
+
+#ifdef ENCODE_DEBUG
+  data->debug = 0;
+  data->depth = -2;
+#endif
+
+  if(args > 2 && TYPEOF(Pike_sp[2-args]) == T_OBJECT)
+  {
+    if (SUBTYPEOF(Pike_sp[2-args]))
+      Pike_error("The codec may not be a subtyped object yet.\n");
+
+    data->codec=Pike_sp[2-args].u.object;
+    add_ref (data->codec);
+  }else{
+    data->codec=NULL;
+  }
+
+  SET_ONERROR(tmp, free_encode_data, data);
+  addstr("\266ke0", 4);
+
+  encode_value2(Pike_sp-args, data, 1);
+
+  for (i = 0; i < data->delayed->size; i++)
+    encode_value2 (ITEM(data->delayed) + i, data, 2);
+
+  encode_flush(data);
+
+  CALL_AND_UNSET_ONERROR(tmp);
+
+  pop_n_elems(args);
+  push_int64(data->flushed);
+}
+
+/*! @endmodule
+ */
 
 struct unfinished_prog_link
 {
@@ -11,6 +11,7 @@
 struct encode_data;
 void f_encode_value(INT32 args);
 void f_encode_value_canonic(INT32 args);
+void f_encode_value_to(INT32 args);
 struct decode_data;
 void f_decode_value(INT32 args);
 /* Prototypes end here */
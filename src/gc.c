@@ -194,6 +194,14 @@ static cpu_time_t last_gc_end_real_time = -1;
 cpu_time_t auto_gc_time = 0;
 cpu_time_t auto_gc_real_time = 0;
 
+/* Pause time statistics. Bucket 0 in gc_pause_histogram counts gc
+ * runs shorter than 1 ms, bucket n (0 < n < GC_PAUSE_BUCKETS - 1)
+ * those between 2^(n-1) and 2^n ms, and the last one everything
+ * longer than that. */
+#define GC_PAUSE_BUCKETS 16
+static INT64 gc_pause_histogram[GC_PAUSE_BUCKETS];
+static cpu_time_t last_gc_pause = 0, max_gc_pause = 0;
+
 struct link_frame		/* See cycle checking blurb below. */
 {
   void *data;
@@ -4031,8 +4039,20 @@ size_t do_gc(void *UNUSED(ignored), int explicit_call)
     else last_non_gc_time = (cpu_time_t) -1;
     last_gc_end_real_time = get_real_time();
     if (last_gc_end_real_time > gc_start_real_time) {
-      gc_time = gc_time * multiplier +
-	(last_gc_end_real_time - gc_start_real_time) * (1.0 - multiplier);
+      last_gc_pause = last_gc_end_real_time - gc_start_real_time;
+      gc_time = gc_time * multiplier + last_gc_pause * (1.0 - multiplier);
+    }
+    else last_gc_pause = 0;
+
+    {
+      cpu_time_t pause_ms = last_gc_pause / (CPU_TIME_TICKS / 1000);
+      int bucket = 0;
+      while (pause_ms && bucket < GC_PAUSE_BUCKETS - 1) {
+	pause_ms >>= 1;
+	bucket++;
+      }
+      gc_pause_histogram[bucket]++;
+      if (last_gc_pause > max_gc_pause) max_gc_pause = last_gc_pause;
     }
 
 #ifdef GC_INTERVAL_DEBUG
@@ -4270,6 +4290,18 @@ size_t do_gc(void *UNUSED(ignored), int explicit_call)
  *!     @member int "total_gc_real_time"
  *!       The total amount of real time that has been spent in
  *!       implicit GC runs, in nanoseconds.
+ *!     @member int "last_gc_pause"
+ *!       Length of the last gc run, measured in real time
+ *!       nanoseconds.
+ *!     @member int "max_gc_pause"
+ *!       Length of the longest gc run so far, measured in real time
+ *!       nanoseconds.
+ *!     @member array(int) "gc_pause_histogram"
+ *!       Number of gc runs (both implicit and explicit) grouped by
+ *!       their length. The first element counts the runs shorter
+ *!       than 1 ms, element @expr{n@} the runs between
+ *!       @expr{2^(n-1)@} and @expr{2^n@} ms, and the last element
+ *!       all runs longer than that.
  *!   @endmapping
  *!
  *! @seealso
@@ -4353,6 +4385,31 @@ void f__gc_status(INT32 args)
 #endif
   size++;
 
+  push_static_text ("last_gc_pause");
+  push_int64 (last_gc_pause);
+#ifndef LONG_CPU_TIME
+  push_int (1000000000 / CPU_TIME_TICKS);
+  o_multiply();
+#endif
+  size++;
+
+  push_static_text ("max_gc_pause");
+  push_int64 (max_gc_pause);
+#ifndef LONG_CPU_TIME
+  push_int (1000000000 / CPU_TIME_TICKS);
+  o_multiply();
+#endif
+  size++;
+
+  push_static_text ("gc_pause_histogram");
+  {
+    int i;
+    for (i = 0; i < GC_PAUSE_BUCKETS; i++)
+      push_int64 (gc_pause_histogram[i]);
+    f_aggregate (GC_PAUSE_BUCKETS);
+  }
+  size++;
+
 #ifdef PIKE_DEBUG
   push_static_text ("max_rec_frames");
   push_int64 ((INT64) tot_max_rec_frames);
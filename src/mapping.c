@@ -23,8 +23,13 @@
 #include "opcodes.h"
 #include "stuff.h"
 
-/* Average number of keypairs per slot when allocating. */
-#define AVG_LINK_LENGTH 4
+/* Average number of keypairs per slot when allocating.
+ *
+ * This is also the maximum average chain length, since the hash table
+ * is grown when all keypairs are in use. Every step in a chain is a
+ * dependent load that is likely to miss the cache, so it's kept short
+ * at the cost of one hash slot pointer per two keypairs. */
+#define AVG_LINK_LENGTH 2
 
 /* Minimum number of elements in a hashtable is half of the slots. */
 #define MIN_LINK_LENGTH_NUMERATOR	1
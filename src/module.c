@@ -341,6 +341,7 @@ static void exit_builtin_modules(void)
   cleanup_shared_string_table();
 
   free_dynamic_load();
+  free_all_array_blocks();
   first_mapping=0;
   free_all_mapping_blocks();
   first_object=0;
@@ -61,6 +61,10 @@
 #include <linux/if.h>
 #endif
 
+#ifdef HAVE_LINUX_TLS_H
+#include <linux/tls.h>
+#endif
+
 #ifdef HAVE_SYS_UIO_H
 #include <sys/uio.h>
 #endif /* HAVE_SYS_UIO_H */
@@ -4837,6 +4841,181 @@ static void file_setsockopt(INT32 args)
   push_int(!i);
 }
 
+#if defined(HAVE_LINUX_TLS_H) && defined(TLS_TX) && \
+  defined(HAVE_STRUCT_MSGHDR_MSG_CONTROL)
+#define HAVE_KTLS
+
+#ifndef SOL_TLS
+#define SOL_TLS		282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP		31
+#endif
+
+/*! @decl int(0..1) set_ktls_tx(int version, string(8bit) key, @
+ *!                             string(8bit) salt, string(8bit) iv, @
+ *!                             int seq)
+ *!
+ *! Hand the TLS record encryption for data written to this socket
+ *! over to the kernel (Linux kTLS).
+ *!
+ *! After a successful call, data written to the socket (including
+ *! with @[Stdio.sendfile()]) is sent as encrypted TLS application
+ *! data records. Other record types must be sent with
+ *! @[send_tls_record()].
+ *!
+ *! Only AES-GCM with 128 or 256 bit keys is supported.
+ *!
+ *! @param version
+ *!   TLS protocol version, eg @expr{0x303@} for TLS 1.2.
+ *!
+ *! @param key
+ *!   The write key.
+ *!
+ *! @param salt
+ *!   The implicit part of the nonce (4 bytes).
+ *!
+ *! @param iv
+ *!   The explicit part of the nonce (8 bytes).
+ *!
+ *! @param seq
+ *!   Sequence number of the next record.
+ *!
+ *! @returns
+ *!   1 if successful, 0 if not (and sets errno()).
+ *!
+ *! @note
+ *!   This function is only available on systems with kernel TLS support.
+ *!
+ *! @seealso
+ *!   @[SSL.File()->enable_ktls()]
+ */
+static void file_set_ktls_tx(INT32 args)
+{
+  INT_TYPE version, seq;
+  struct pike_string *key, *salt, *iv;
+  union {
+    struct tls12_crypto_info_aes_gcm_128 gcm_128;
+    struct tls12_crypto_info_aes_gcm_256 gcm_256;
+  } info;
+  unsigned char *rec_seq;
+  size_t len, rec_seq_len;
+  int fd = FD;
+  int i;
+
+  get_all_args("set_ktls_tx", args, "%i%n%n%n%i",
+	       &version, &key, &salt, &iv, &seq);
+  key->flags |= STRING_CLEAR_ON_EXIT;
+
+  memset(&info, 0, sizeof(info));
+  switch(key->len) {
+  case TLS_CIPHER_AES_GCM_128_KEY_SIZE:
+    info.gcm_128.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+    if ((salt->len != TLS_CIPHER_AES_GCM_128_SALT_SIZE) ||
+	(iv->len != TLS_CIPHER_AES_GCM_128_IV_SIZE))
+      Pike_error("Invalid salt or iv size.\n");
+    memcpy(info.gcm_128.key, key->str, key->len);
+    memcpy(info.gcm_128.salt, salt->str, salt->len);
+    memcpy(info.gcm_128.iv, iv->str, iv->len);
+    rec_seq = info.gcm_128.rec_seq;
+    rec_seq_len = sizeof(info.gcm_128.rec_seq);
+    len = sizeof(info.gcm_128);
+    break;
+  case TLS_CIPHER_AES_GCM_256_KEY_SIZE:
+    info.gcm_256.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+    if ((salt->len != TLS_CIPHER_AES_GCM_256_SALT_SIZE) ||
+	(iv->len != TLS_CIPHER_AES_GCM_256_IV_SIZE))
+      Pike_error("Invalid salt or iv size.\n");
+    memcpy(info.gcm_256.key, key->str, key->len);
+    memcpy(info.gcm_256.salt, salt->str, salt->len);
+    memcpy(info.gcm_256.iv, iv->str, iv->len);
+    rec_seq = info.gcm_256.rec_seq;
+    rec_seq_len = sizeof(info.gcm_256.rec_seq);
+    len = sizeof(info.gcm_256);
+    break;
+  default:
+    Pike_error("Unsupported key size.\n");
+  }
+  info.gcm_128.info.version = version;
+  /* The record sequence number is big-endian. */
+  while (rec_seq_len--) {
+    rec_seq[rec_seq_len] = seq & 0xff;
+    seq >>= 8;
+  }
+
+  i = fd_setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls"));
+  if (!i)
+    i = fd_setsockopt(fd, SOL_TLS, TLS_TX, (char *)&info, len);
+  ERRNO = i ? errno : 0;
+
+  /* Don't leave the key on the stack. */
+  guaranteed_memset(&info, 0, sizeof(info));
+
+  pop_n_elems(args);
+  push_int(!i);
+}
+
+/*! @decl int send_tls_record(int content_type, string(8bit) data)
+ *!
+ *! Send @[data] as a single TLS record of type @[content_type] on a
+ *! socket where the encryption has been handed over to the kernel
+ *! with @[set_ktls_tx()].
+ *!
+ *! @returns
+ *!   Returns the number of bytes sent, or @expr{-1@} on failure
+ *!   (and sets errno()).
+ *!
+ *! @note
+ *!   This function is only available on systems with kernel TLS support.
+ */
+static void file_send_tls_record(INT32 args)
+{
+  INT_TYPE type;
+  struct pike_string *data;
+  struct msghdr msg;
+  struct iovec iov;
+  char cbuf[CMSG_SPACE(sizeof(unsigned char))];
+  struct cmsghdr *cmsg;
+  ptrdiff_t written;
+  int fd = FD;
+  int e;
+
+  get_all_args("send_tls_record", args, "%i%n", &type, &data);
+
+  if (fd < 0)
+    Pike_error("File not open.\n");
+
+  memset(&msg, 0, sizeof(msg));
+  memset(cbuf, 0, sizeof(cbuf));
+  iov.iov_base = data->str;
+  iov.iov_len = data->len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cbuf;
+  msg.msg_controllen = sizeof(cbuf);
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+  *((unsigned char *)CMSG_DATA(cmsg)) = type;
+  msg.msg_controllen = cmsg->cmsg_len;
+
+  do {
+    THREADS_ALLOW();
+    written = sendmsg(fd, &msg, 0);
+    e = errno;
+    THREADS_DISALLOW();
+
+    check_threads_etc();
+  } while ((written < 0) && (e == EINTR));
+  ERRNO = (written < 0) ? e : 0;
+
+  pop_n_elems(args);
+  push_int(written);
+}
+#endif /* HAVE_LINUX_TLS_H && TLS_TX && HAVE_STRUCT_MSGHDR_MSG_CONTROL */
+
 #ifdef HAVE_SYS_UN_H
 #include <sys/un.h>
 
@@ -193,6 +193,12 @@ FILE_FUNC("set_keepalive",file_set_keepalive, tFunc(tInt,tInt))
 /* function(int,int:int) */
 FILE_FUNC("setsockopt",file_setsockopt, tFunc(tInt tInt,tInt))
 
+#ifdef HAVE_KTLS
+FILE_FUNC("set_ktls_tx",file_set_ktls_tx,
+	  tFunc(tInt tStr8 tStr8 tStr8 tInt,tInt01))
+FILE_FUNC("send_tls_record",file_send_tls_record, tFunc(tInt tStr8,tInt))
+#endif
+
 #if defined(HAVE_FSETXATTR) && defined(HAVE_FGETXATTR) && defined(HAVE_FLISTXATTR)
 FILE_FUNC( "listxattr", file_listxattr, tFunc(tVoid,tArr(tStr)))
 FILE_FUNC( "setxattr", file_setxattr, tFunc(tStr tStr tInt,tInt))
@@ -133,6 +133,8 @@ struct udp_storage {
   int protocol;
 
   struct svalue read_callback;	/* Mapped. */
+
+  char *batch_buf;		/* Idle receive buffer for read_batch(). */
 };
 
 void zero_udp(struct object *ignored);
@@ -751,6 +753,89 @@ void udp_wait(INT32 args)
 
 #define UDP_BUFFSIZE 65536
 
+/* Max number of datagrams per recvmmsg(2) or sendmmsg(2) call. */
+#define UDP_BATCH_SIZE 32
+
+/* Handle a failed receive. Returns if the caller should return
+ * no data, and throws otherwise.
+ */
+static void udp_read_error(int e, int flags)
+{
+  switch(e)
+  {
+#ifdef WSAEBADF
+  case WSAEBADF:
+#endif
+  case EBADF:
+    if (THIS->box.backend)
+      set_fd_callback_events (&THIS->box, 0, 0);
+    Pike_error("Socket closed\n");
+#ifdef ESTALE
+  case ESTALE:
+#endif
+  case EIO:
+    if (THIS->box.backend)
+      set_fd_callback_events (&THIS->box, 0, 0);
+    Pike_error("I/O error\n");
+  case ENOMEM:
+#ifdef ENOSR
+  case ENOSR:
+#endif /* ENOSR */
+    Pike_error("Out of memory\n");
+#ifdef ENOTSOCK
+  case ENOTSOCK:
+    Pike_fatal("reading from non-socket fd!!!\n");
+#endif
+  case EINVAL:
+    if (!(flags & MSG_OOB)) {
+      Pike_error("Socket read failed with EINVAL.\n");
+    }
+    /* FALL_THROUGH */
+  case EWOULDBLOCK:
+    return;
+
+  default:
+    Pike_error("Socket read failed with errno %d.\n", e);
+  }
+}
+
+/* Push the mapping for a received datagram. */
+static void push_udp_datagram(const char *data, ptrdiff_t len,
+			      PIKE_SOCKADDR *from)
+{
+  char buffer[64];
+
+  push_static_text("data");
+  push_string( make_shared_binary_string(data, len) );
+
+  push_static_text("ip");
+#ifdef fd_inet_ntop
+  if (!fd_inet_ntop( SOCKADDR_FAMILY(*from), SOCKADDR_IN_ADDR(*from),
+		     buffer, sizeof(buffer) )) {
+    push_static_text("UNSUPPORTED");
+  } else {
+    /* NOTE: IPv6-mapped IPv4 addresses may only
+     *       connect to other IPv4 addresses.
+     *
+     * Make the Pike-level code believe it has an actual IPv4 address
+     * when getting a mapped address (::FFFF:a.b.c.d).
+     */
+    if ((!strncmp(buffer, "::FFFF:", 7) || !strncmp(buffer, "::ffff:", 7)) &&
+	!strchr(buffer + 7, ':')) {
+      push_text(buffer+7);
+    } else {
+      push_text(buffer);
+    }
+  }
+#else
+  push_text( inet_ntoa( *SOCKADDR_IN_ADDR(*from) ) );
+#endif
+
+  push_constant_text("port");
+  push_int(ntohs(from->ipv4.sin_port));
+  f_aggregate_mapping( 6 );
+}
+
 /*! @decl mapping(string:int|string) read()
  *! @decl mapping(string:int|string) read(int flag)
  *!
@@ -810,80 +895,138 @@ void udp_read(INT32 args)
 
   if(res<0)
   {
-    switch(e)
-    {
-#ifdef WSAEBADF
-       case WSAEBADF:
-#endif
-       case EBADF:
-	  if (THIS->box.backend)
-	    set_fd_callback_events (&THIS->box, 0, 0);
-	  Pike_error("Socket closed\n");
-#ifdef ESTALE
-       case ESTALE:
-#endif
-       case EIO:
-	  if (THIS->box.backend)
-	    set_fd_callback_events (&THIS->box, 0, 0);
-	  Pike_error("I/O error\n");
-       case ENOMEM:
-#ifdef ENOSR
-       case ENOSR:
-#endif /* ENOSR */
-	  Pike_error("Out of memory\n");
-#ifdef ENOTSOCK
-       case ENOTSOCK:
-	  Pike_fatal("reading from non-socket fd!!!\n");
-#endif
-       case EINVAL:
-	 if (!(flags & MSG_OOB)) {
-	   Pike_error("Socket read failed with EINVAL.\n");
-	 }
-	 /* FALL_THROUGH */
-       case EWOULDBLOCK:
-	  push_int( 0 );
-	  return;
-
-       default:
-	  Pike_error("Socket read failed with errno %d.\n", e);
-    }
+    udp_read_error(e, flags);
+    push_int( 0 );
+    return;
+  }
+
+  push_udp_datagram(buffer, res, &from);
+
+  if (!(THIS->inet_flags & PIKE_INET_FLAG_NB))
+    INVALIDATE_CURRENT_TIME();
+}
+
+#if defined(HAVE_RECVMMSG) && defined(MSG_WAITFORONE)
+/* Return a receive buffer to the object after use, unless the
+ * socket has been closed or another reader has returned one first.
+ */
+static void release_batch_buf(char *buf)
+{
+  if ((FD < 0) || THIS->batch_buf)
+    free(buf);
+  else
+    THIS->batch_buf = buf;
+}
+
+/*! @decl array(mapping(string:int|string)) read_batch(int(1..) max)
+ *! @decl array(mapping(string:int|string)) read_batch(int(1..) max, @
+ *!                                                   int flag)
+ *!
+ *! Read up to @[max] datagrams from the UDP socket with a single
+ *! system call.
+ *!
+ *! Waits like @[read()] for the first datagram (unless in nonblocking
+ *! mode), and then returns the datagrams that are available without
+ *! waiting.
+ *!
+ *! Flag @[flag] is a bitfield, 1 for out of band data and 2 for peek
+ *!
+ *! @returns
+ *!   Returns an array of mappings in the format returned by
+ *!   @[read()], or @expr{0@} (zero) if no datagram was available
+ *!   in nonblocking mode.
+ *!
+ *! @note
+ *!   This function is only available on systems with @tt{recvmmsg(2)@}.
+ *!
+ *! @seealso
+ *!   @[read()], @[send_batch()]
+ */
+static void udp_read_batch(INT32 args)
+{
+  INT_TYPE max, flag = 0;
+  int flags = MSG_WAITFORONE, res = 0, fd, e, i;
+  struct mmsghdr msgs[UDP_BATCH_SIZE];
+  struct iovec iov[UDP_BATCH_SIZE];
+  PIKE_SOCKADDR from[UDP_BATCH_SIZE];
+  char *buf;
+  ONERROR uwp;
+
+  get_all_args("read_batch", args, "%+.%i", &max, &flag);
+
+  if (flag & 1) {
+    flags |= MSG_OOB;
   }
-  /* Now comes the interresting part.
-   * make a nice mapping from this stuff..
+  if (flag & 2) {
+#ifdef MSG_PEEK
+    flags |= MSG_PEEK;
+#endif /* MSG_PEEK */
+  }
+  if (flag & ~3) {
+    Pike_error("Illegal 'flags' value passed to "
+	       "udp->read_batch(int max, [int flags])\n");
+  }
+  if (max > UDP_BATCH_SIZE) max = UDP_BATCH_SIZE;
+  if (!max) max = 1;
+
+  pop_n_elems(args);
+  fd = FD;
+  if (FD < 0)
+    Pike_error("Stdio.UDP->read_batch: not open\n");
+
+  /* NB: The buffer is detached from the object while in use, so that
+   *     neither a concurrent close() nor another reader can touch it
+   *     while the threads are allowed. Pages that are never received
+   *     into are never touched.
    */
-  push_static_text("data");
-  push_string( make_shared_binary_string(buffer, res) );
+  if ((buf = THIS->batch_buf))
+    THIS->batch_buf = NULL;
+  else
+    buf = xalloc(UDP_BATCH_SIZE * UDP_BUFFSIZE);
+  SET_ONERROR(uwp, free, buf);
+
+  memset(msgs, 0, sizeof(msgs));
+  for (i = 0; i < max; i++) {
+    iov[i].iov_base = buf + i * UDP_BUFFSIZE;
+    iov[i].iov_len = UDP_BUFFSIZE;
+    msgs[i].msg_hdr.msg_iov = iov + i;
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = from + i;
+    msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+  }
 
-  push_static_text("ip");
-#ifdef fd_inet_ntop
-  if (!fd_inet_ntop( SOCKADDR_FAMILY(from), SOCKADDR_IN_ADDR(from),
-		     buffer, sizeof(buffer) )) {
-    push_static_text("UNSUPPORTED");
-  } else {
-    /* NOTE: IPv6-mapped IPv4 addresses may only
-     *       connect to other IPv4 addresses.
-     *
-     * Make the Pike-level code believe it has an actual IPv4 address
-     * when getting a mapped address (::FFFF:a.b.c.d).
-     */
-    if ((!strncmp(buffer, "::FFFF:", 7) || !strncmp(buffer, "::ffff:", 7)) &&
-	!strchr(buffer + 7, ':')) {
-      push_text(buffer+7);
-    } else {
-      push_text(buffer);
-    }
+  do {
+    THREADS_ALLOW();
+    res = recvmmsg(fd, msgs, max, flags, NULL);
+    e = errno;
+    THREADS_DISALLOW();
+
+    check_threads_etc();
+  } while((res==-1) && (e==EINTR));
+
+  THIS->my_errno=errno=e;
+
+  if(res<0)
+  {
+    UNSET_ONERROR(uwp);
+    release_batch_buf(buf);
+    udp_read_error(e, flags);
+    push_int( 0 );
+    return;
   }
-#else
-  push_text( inet_ntoa( *SOCKADDR_IN_ADDR(from) ) );
-#endif
 
-  push_constant_text("port");
-  push_int(ntohs(from.ipv4.sin_port));
-  f_aggregate_mapping( 6 );
+  for (i = 0; i < res; i++) {
+    push_udp_datagram(iov[i].iov_base, msgs[i].msg_len, from + i);
+  }
+  f_aggregate(res);
+
+  UNSET_ONERROR(uwp);
+  release_batch_buf(buf);
 
   if (!(THIS->inet_flags & PIKE_INET_FLAG_NB))
     INVALIDATE_CURRENT_TIME();
 }
+#endif /* HAVE_RECVMMSG && MSG_WAITFORONE */
 
 /*! @decl int send(string to, int|string port, string message)
  *! @decl int send(string to, int|string port, string message, int flags)
@@ -1001,6 +1144,137 @@ void udp_sendto(INT32 args)
     INVALIDATE_CURRENT_TIME();
 }
 
+#ifdef HAVE_SENDMMSG
+/*! @decl int send_batch(array(array(string|int)) messages)
+ *! @decl int send_batch(array(array(string|int)) messages, int flags)
+ *!
+ *! Send several datagrams with as few system calls as possible.
+ *!
+ *! @param messages
+ *!   Array of datagrams to send, each in the form
+ *!   @expr{({ to, port, message })@}, as the arguments to @[send()].
+ *!
+ *! @param flags
+ *!   As for @[send()].
+ *!
+ *! @returns
+ *!   Returns the number of datagrams that were sent, which may be
+ *!   less than @expr{sizeof(messages)@}, eg if the send buffers are
+ *!   full. Returns @expr{-1@} if no datagram could be sent. Check
+ *!   @[errno()] for the cause.
+ *!
+ *! @note
+ *!   This function is only available on systems with @tt{sendmmsg(2)@}.
+ *!
+ *! @seealso
+ *!   @[send()], @[read_batch()]
+ */
+static void udp_send_batch(INT32 args)
+{
+  struct array *a;
+  INT_TYPE flag = 0;
+  int flags = 0, fd, e = 0;
+  ptrdiff_t pos = 0, sent = 0;
+  struct mmsghdr msgs[UDP_BATCH_SIZE];
+  struct iovec iov[UDP_BATCH_SIZE];
+  PIKE_SOCKADDR to[UDP_BATCH_SIZE];
+
+  if(FD < 0)
+    Pike_error("UDP: not open\n");
+
+  get_all_args("send_batch", args, "%a.%i", &a, &flag);
+
+  if (flag & 1) {
+    flags |= MSG_OOB;
+  }
+  if (flag & 2) {
+#ifdef MSG_DONTROUTE
+    flags |= MSG_DONTROUTE;
+#endif /* MSG_DONTROUTE */
+  }
+  if (flag & ~3) {
+    Pike_error("Illegal 'flags' value passed to "
+	       "Stdio.UDP->send_batch(array messages, int flags)\n");
+  }
+
+  fd = FD;
+  while (pos < a->size) {
+    int i, cnt = MINIMUM(a->size - pos, UDP_BATCH_SIZE);
+    int res;
+
+    memset(msgs, 0, cnt * sizeof(msgs[0]));
+    for (i = 0; i < cnt; i++) {
+      struct svalue *item = ITEM(a) + pos + i;
+      struct svalue *m;
+
+      if ((TYPEOF(*item) != PIKE_T_ARRAY) || (item->u.array->size != 3))
+	SIMPLE_ARG_TYPE_ERROR("send_batch", 1,
+			      "array(array(string|int))");
+      m = ITEM(item->u.array);
+      if ((TYPEOF(m[0]) != PIKE_T_STRING) || m[0].u.string->size_shift ||
+	  ((TYPEOF(m[1]) != PIKE_T_STRING) && (TYPEOF(m[1]) != PIKE_T_INT)) ||
+	  (TYPEOF(m[2]) != PIKE_T_STRING) || m[2].u.string->size_shift)
+	SIMPLE_ARG_TYPE_ERROR("send_batch", 1,
+			      "array(array(string|int))");
+
+      msgs[i].msg_hdr.msg_namelen =
+	get_inet_addr(to + i, m[0].u.string->str,
+		      (TYPEOF(m[1]) == PIKE_T_STRING?
+		       m[1].u.string->str : NULL),
+		      (TYPEOF(m[1]) == PIKE_T_INT?
+		       m[1].u.integer : -1),
+		      THIS->inet_flags);
+      msgs[i].msg_hdr.msg_name = to + i;
+      iov[i].iov_base = m[2].u.string->str;
+      iov[i].iov_len = m[2].u.string->len;
+      msgs[i].msg_hdr.msg_iov = iov + i;
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    do {
+      THREADS_ALLOW();
+      res = sendmmsg(fd, msgs, cnt, flags);
+      e = errno;
+      THREADS_DISALLOW();
+
+      check_threads_etc();
+    } while((res == -1) && e==EINTR);
+
+    if (res < 0) {
+      THIS->my_errno = e;
+      switch(e)
+      {
+      case EBADF:
+	if (THIS->box.backend)
+	  set_fd_callback_events (&THIS->box, 0, 0);
+	Pike_error("Socket closed\n");
+      case ENOMEM:
+#ifdef ENOSR
+      case ENOSR:
+#endif /* ENOSR */
+	Pike_error("Out of memory\n");
+#ifdef ENOTSOCK
+      case ENOTSOCK:
+	if (THIS->box.backend)
+	  set_fd_callback_events (&THIS->box, 0, 0);
+	Pike_error("Not a socket!!!\n");
+#endif
+      }
+      if (!sent) sent = -1;
+      break;
+    }
+
+    sent += res;
+    pos += res;
+    if (res < cnt) break;
+  }
+
+  pop_n_elems(args);
+  push_int64(sent);
+  INVALIDATE_CURRENT_TIME();
+}
+#endif /* HAVE_SENDMMSG */
+
 
 static int got_udp_event (struct fd_callback_box *box, int DEBUGUSED(event))
 {
@@ -1044,6 +1318,11 @@ int low_exit_udp()
   unhook_fd_callback_box(&THIS->box);
   FD = -1;
 
+  if (THIS->batch_buf) {
+    free(THIS->batch_buf);
+    THIS->batch_buf = NULL;
+  }
+
   if(fd != -1)
   {
     THREADS_ALLOW();
@@ -1465,6 +1744,17 @@ void init_stdio_udp(void)
   ADD_FUNCTION("send",udp_sendto,
 	       tFunc(tStr tOr(tInt,tStr) tStr tOr(tVoid,tInt),tInt),0);
 
+#if defined(HAVE_RECVMMSG) && defined(MSG_WAITFORONE)
+  ADD_FUNCTION("read_batch",udp_read_batch,
+	       tFunc(tIntPos tOr(tInt,tVoid),
+		     tOr(tArr(tMap(tStr,tOr(tInt,tStr))),tInt0)),0);
+#endif
+
+#ifdef HAVE_SENDMMSG
+  ADD_FUNCTION("send_batch",udp_send_batch,
+	       tFunc(tArr(tArr(tOr(tStr,tInt))) tOr(tVoid,tInt),tInt),0);
+#endif
+
   ADD_FUNCTION("connect",udp_connect,
 	       tFunc(tString tOr(tInt,tStr),tInt),0);
 
@@ -188,6 +188,9 @@ void reorder(char *memory, INT32 nitems, INT32 size,INT32 *order)
 #ifdef HAVE_CRC32_INTRINSICS
 #define CRC32SI(H,P) H=__builtin_ia32_crc32si(H,*(P))
 #define CRC32SQ(H,P) H=__builtin_ia32_crc32qi(H,*(P))
+#ifdef __amd64__
+#define CRC32SD(H,P) H=__builtin_ia32_crc32di(H,*(P))
+#endif
 #else
 
 /* GCC versions without __builtin_ia32_crc32* also lacks the support
@@ -205,6 +208,14 @@ void reorder(char *memory, INT32 nitems, INT32 size,INT32 *order)
     __asm__ __volatile__(                                             \
         ".byte 0xf2, 0xf, 0x38, 0xf0, 0xf1"                           \
         :"=S"(H) :"0"(H), "c"(*(P)))
+
+#ifdef __amd64__
+/* crc32q %rcx, %rsi */
+#define CRC32SD(H,P)                                                  \
+    __asm__ __volatile__(                                             \
+        ".byte 0xf2, 0x48, 0xf, 0x38, 0xf1, 0xf1"                     \
+        :"=S"(H) :"0"(H), "c"(*(P)))
+#endif
 #endif
 
 ATTRIBUTE((const)) static inline int supports_sse42( )
@@ -311,14 +322,69 @@ static inline size_t low_hashmem_ia32_crc32( const void *s, size_t len,
     CRC32SI(h,e);
   }
 #if SIZEOF_CHAR_P > 4
-    /* FIXME: We could use the long long crc32 instructions that work on 64 bit values.
-     * however, those are only available when compiling to amd64.
+    /* NB: See low_hashmem_amd64_crc32() below for a variant that
+     *     uses the 64 bit crc32 instruction.
      */
   return (((size_t)h)<<32) | h;
 #endif
   return h;
 }
 
+#ifdef __amd64__
+/* Same as low_hashmem_ia32_crc32(), but hashes eight bytes per
+ * instruction. This roughly doubles the throughput for long strings.
+ */
+#ifdef HAVE_CRC32_INTRINSICS
+ATTRIBUTE((target("sse4")))
+#endif
+ATTRIBUTE((hot))
+static inline size_t low_hashmem_amd64_crc32( const void *s, size_t len,
+					      size_t nbytes, size_t key )
+{
+  unsigned INT64 h = len;
+  const unsigned INT64 *p = s;
+
+  if( key )
+      return low_hashmem_siphash24(s,len,nbytes,key);
+
+  if( (nbytes >= len) || UNLIKELY(nbytes < 32) )
+  {
+    /* Hash the whole memory area, or all of the short prefix. */
+    size_t n = (nbytes >= len)? len : nbytes;
+    const unsigned INT64 *e = p + (n>>3);
+    const unsigned char *c = (const unsigned char*)e;
+
+    /* .. all full 64 bit words .. */
+    while( p<e ) {
+      CRC32SD(h, p++ );
+    }
+
+    n &= 7;
+
+    /* any remaining bytes. */
+    while( n-- )
+      CRC32SQ( h, c++ );
+  } else {
+    const unsigned INT64 *e = p+(nbytes>>3);
+    while( p+3 < e )
+    {
+      CRC32SD(h,&p[0]);
+      CRC32SD(h,&p[1]);
+      CRC32SD(h,&p[2]);
+      CRC32SD(h,&p[3]);
+      p+=4;
+    }
+    while( p<e ) {
+      CRC32SD(h, p++ );
+    }
+    /* include 8 bytes from the end. See low_hashmem_ia32_crc32(). */
+    CRC32SD(h, (const unsigned INT64 *)((const unsigned char *)s+len-8));
+  }
+  h &= 0xffffffff;
+  return (size_t)((h<<32) | h);
+}
+#endif /* __amd64__ */
+
 #ifdef __i386__
 ATTRIBUTE((fastcall))
 #endif
@@ -327,7 +393,11 @@ ATTRIBUTE((fastcall))
 static void init_hashmem()
 {
   if( supports_sse42() )
+#ifdef __amd64__
+    low_hashmem = low_hashmem_amd64_crc32;
+#else
     low_hashmem = low_hashmem_ia32_crc32;
+#endif
   else
     low_hashmem = low_hashmem_siphash24;
 }
@@ -17,6 +17,11 @@
 #include "module_support.h"
 #include "pike_macros.h"
 #include "pike_search.h"
+#include "bitvector.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 ptrdiff_t pike_search_struct_offset;
 #define OB2MSEARCH(O) ((struct pike_mem_searcher *)((O)->storage+pike_search_struct_offset))
@@ -101,6 +106,19 @@ static const struct SearchMojtVtable nil_search_vtable = {
 #define BMHASH21 BMHASH20
 #define BMHASH22 BMHASH20
 
+#ifdef __SSE2__
+/* Vector operations on haystack characters, see first_last_search(). */
+#define SSE_CHARS0	16
+#define SSE_CHARS1	8
+#define SSE_CHARS2	4
+#define SSE_SET1_0(C)	_mm_set1_epi8((char)(C))
+#define SSE_SET1_1(C)	_mm_set1_epi16((short)(C))
+#define SSE_SET1_2(C)	_mm_set1_epi32((int)(C))
+#define SSE_CMPEQ_0	_mm_cmpeq_epi8
+#define SSE_CMPEQ_1	_mm_cmpeq_epi16
+#define SSE_CMPEQ_2	_mm_cmpeq_epi32
+#endif
+
 #define NCHAR NameN(p_wchar)
 #define HCHAR NameH(p_wchar)
 
@@ -58,6 +58,9 @@ INTERMEDIATE(memchr_memcmp5)
 INTERMEDIATE(memchr_memcmp6)
 INTERMEDIATE(boyer_moore_hubbe)
 INTERMEDIATE(hubbe_search)
+#ifdef __SSE2__
+INTERMEDIATE(first_last_search)
+#endif
 
 
 /* */
@@ -248,7 +251,15 @@ void NameN(init_memsearch)(
     case 20: case 21: case 22: case 23: case 24:
     case 25: case 26: case 27: case 28: case 29:
     case 30: case 31: case 32: case 33: case 34:
+#ifdef __SSE2__
+      s->data.fl.needle=needle;
+      s->data.fl.needlelen=needlelen;
+      s->mojt.vtab=& PxC3(first_last_search,NSHIFT,_vtable);
+      s->mojt.data=(void *)& s->data.fl;
+      return;
+#else
       break;
+#endif
 
   default:
     if(max_haystacklen > needlelen + 64)
@@ -156,6 +156,65 @@ HCHAR *NameNH(boyer_moore_hubbe)(struct boyer_moore_hubbe_searcher *s,
 }
 
 
+#ifdef __SSE2__
+/* Compare the first and the last character of the needle against
+ * a vector of candidate positions at a time, and only compare the
+ * rest of the needle where both match.
+ */
+HCHAR *NameNH(first_last_search)(struct first_last_searcher *s,
+				 HCHAR *haystack,
+				 ptrdiff_t haystacklen)
+{
+  NCHAR *needle = NEEDLE;
+  ptrdiff_t nlen = NEEDLELEN;
+  NCHAR first = needle[0];
+  NCHAR last = needle[nlen-1];
+  ptrdiff_t i, end;
+  __m128i vfirst, vlast;
+
+  if(nlen > haystacklen) return 0;
+#if NSHIFT > HSHIFT
+  if(((HCHAR)first != first) || ((HCHAR)last != last)) return 0;
+#endif
+
+  /* Last possible start of a match. */
+  end = haystacklen - nlen;
+
+  vfirst = NameH(SSE_SET1_)(first);
+  vlast = NameH(SSE_SET1_)(last);
+
+  for(i = 0; i + NameH(SSE_CHARS) <= end + 1; i += NameH(SSE_CHARS))
+  {
+    __m128i a = _mm_loadu_si128((__m128i *)(haystack + i));
+    __m128i b = _mm_loadu_si128((__m128i *)(haystack + i + nlen - 1));
+    unsigned INT32 mask =
+      _mm_movemask_epi8(_mm_and_si128(NameH(SSE_CMPEQ_)(a, vfirst),
+				      NameH(SSE_CMPEQ_)(b, vlast)));
+
+    while(mask)
+    {
+      unsigned INT32 bit = ctz32(mask);
+      HCHAR *where = haystack + i + (bit >> HSHIFT);
+
+      if(!NameNH(MEMCMP)(needle + 1, where + 1, nlen - 2))
+	return where;
+
+      /* Clear all the bytes of this character. */
+      mask &= ~(((1 << (1 << HSHIFT)) - 1) << bit);
+    }
+  }
+
+  for(; i <= end; i++)
+  {
+    if((haystack[i] == first) && (haystack[i + nlen - 1] == last) &&
+       !NameNH(MEMCMP)(needle + 1, haystack + i + 1, nlen - 2))
+      return haystack + i;
+  }
+  return 0;
+}
+#endif
+
+
 HCHAR *NameNH(hubbe_search)(struct hubbe_searcher *s,
 			    HCHAR *haystack,
 			    ptrdiff_t haystacklen)
@@ -37,6 +37,16 @@ extern struct program *nettle_hash_program;
 /* Encrypt/decrypt methods are a bit more expensive. */
 #define CIPHER_THREADS_ALLOW_THRESHOLD	1024
 
+/* Compare two digests in time independent of their contents. */
+static inline int pike_nettle_memeql(const unsigned char *a,
+				     const unsigned char *b, size_t len)
+{
+  unsigned char diff = 0;
+  while (len--)
+    diff |= a[len] ^ b[len];
+  return !diff;
+}
+
 #ifdef HAVE_NETTLE_DSA_H
 #include <nettle/dsa.h>
 #endif
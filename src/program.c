@@ -107,6 +107,11 @@ static const int lock_depth = 1;
 /* A value of zero disables this cache */
 #define FIND_FUNCTION_HASHSIZE 16384
 
+/* Number of entries per set in the method lookup cache. Call sites
+ * that see objects of a few different classes would otherwise evict
+ * each other's entries on every call. */
+#define FIND_FUNCTION_WAYS 2
+
 /* Programs with less methods will not use the cache for method lookups.. */
 #define FIND_FUNCTION_HASH_TRESHOLD 0
 
@@ -7259,17 +7264,38 @@ int find_shared_string_identifier(struct pike_string *name,
     )
   {
     size_t hashval;
-    hashval = my_hash_string(name);
-    hashval += prog->id;
-    hashval &= (FIND_FUNCTION_HASHSIZE-1);
-    if(is_same_string(cache[hashval].name,name) &&
-       cache[hashval].id==prog->id)
-      return cache[hashval].fun;
-
-    if(cache[hashval].name) free_string(cache[hashval].name);
-    copy_shared_string(cache[hashval].name,name);
-    cache[hashval].id=prog->id;
-    return cache[hashval].fun=low_find_shared_string_identifier(name,prog);
+    struct ff_hash *set, tmp;
+    int e;
+    /* The string pointer has its low bits fixed by the alignment, so
+     * shift them out and spread the program id over the whole table. */
+    hashval = my_hash_string(name) >> 4;
+    hashval ^= prog->id * 0x9e3779b1U;
+    hashval &= (FIND_FUNCTION_HASHSIZE-1) & ~(FIND_FUNCTION_WAYS-1);
+    set = cache + hashval;
+
+    for(e=0; e<FIND_FUNCTION_WAYS; e++)
+    {
+      if(is_same_string(set[e].name,name) && set[e].id==prog->id)
+      {
+        /* Move the hit to the front of the set. */
+        if(e)
+        {
+          tmp=set[e];
+          memmove(set+1, set, e*sizeof(struct ff_hash));
+          set[0]=tmp;
+        }
+        return set[0].fun;
+      }
+    }
+
+    /* Evict the least recently used entry. */
+    e=low_find_shared_string_identifier(name,prog);
+    if(set[FIND_FUNCTION_WAYS-1].name)
+      free_string(set[FIND_FUNCTION_WAYS-1].name);
+    memmove(set+1, set, (FIND_FUNCTION_WAYS-1)*sizeof(struct ff_hash));
+    copy_shared_string(set[0].name,name);
+    set[0].id=prog->id;
+    return set[0].fun=e;
   }
 #endif /* FIND_FUNCTION_HASHSIZE */
 
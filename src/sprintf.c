@@ -1907,6 +1907,148 @@ static void free_f_sprintf_data (struct format_stack *fs)
   free (fs->format_info_stack);
 }
 
+/*
+ * Plans for simple format strings.
+ *
+ * Format strings that only contain plain %s, %d, %x, %c and %%
+ * directives are parsed once into a list of operations, which is
+ * kept in a small cache indexed by the address of the format string.
+ * Constant format strings are shared, so the same plan is found on
+ * every call.
+ */
+
+#define SPRINTF_PLAN_CACHE_SIZE	64
+#define SPRINTF_PLAN_MAX_OPS	16
+
+#define SPRINTF_PLAN_LITERAL	0
+#define SPRINTF_PLAN_STRING	1	/* %s */
+#define SPRINTF_PLAN_INT	2	/* %d */
+#define SPRINTF_PLAN_HEX	3	/* %x */
+#define SPRINTF_PLAN_CHAR	4	/* %c */
+
+struct sprintf_plan_op
+{
+  int kind;
+  ptrdiff_t start;	/* Literal text in the format string. */
+  ptrdiff_t len;
+};
+
+struct sprintf_plan
+{
+  struct pike_string *format;
+  int num_ops;		/* -1 if the format string isn't simple. */
+  int num_args;
+  struct sprintf_plan_op ops[SPRINTF_PLAN_MAX_OPS];
+};
+
+static struct sprintf_plan sprintf_plans[SPRINTF_PLAN_CACHE_SIZE];
+
+static void compile_sprintf_plan(struct sprintf_plan *plan,
+				 struct pike_string *format)
+{
+  ptrdiff_t i, start = 0;
+  int n = 0, num_args = 0;
+
+  if (plan->format) free_string(plan->format);
+  add_ref(plan->format = format);
+  plan->num_ops = -1;
+
+#define ADD_OP(KIND, START, LEN) do {			\
+    if (n == SPRINTF_PLAN_MAX_OPS) return;		\
+    plan->ops[n].kind = (KIND);				\
+    plan->ops[n].start = (START);			\
+    plan->ops[n].len = (LEN);				\
+    n++;						\
+  } while(0)
+
+  for (i = 0; i < format->len; i++) {
+    int kind;
+
+    if (index_shared_string(format, i) != '%') continue;
+    if (i + 1 == format->len) return;
+
+    if (i > start) ADD_OP(SPRINTF_PLAN_LITERAL, start, i - start);
+    i++;
+    start = i + 1;
+
+    switch(index_shared_string(format, i)) {
+    case '%': ADD_OP(SPRINTF_PLAN_LITERAL, i, 1); continue;
+    case 's': kind = SPRINTF_PLAN_STRING; break;
+    case 'd': kind = SPRINTF_PLAN_INT; break;
+    case 'x': kind = SPRINTF_PLAN_HEX; break;
+    case 'c': kind = SPRINTF_PLAN_CHAR; break;
+    default:
+      /* Modifiers or other directives. */
+      return;
+    }
+    ADD_OP(kind, 0, 0);
+    num_args++;
+  }
+  if (start < format->len) ADD_OP(SPRINTF_PLAN_LITERAL, start, format->len - start);
+
+#undef ADD_OP
+
+  plan->num_ops = n;
+  plan->num_args = num_args;
+}
+
+/* Format the arguments according to a plan for a simple format.
+ * Returns 0 without touching r if the arguments need the generic
+ * code.
+ */
+static int run_sprintf_plan(struct sprintf_plan *plan,
+			    struct string_builder *r,
+			    struct svalue *argp,
+			    ptrdiff_t num_arg)
+{
+  int e, a;
+  PCHARP format = MKPCHARP_STR(plan->format);
+
+  if ((plan->num_ops < 0) || (num_arg != plan->num_args)) return 0;
+
+  for (e = a = 0; e < plan->num_ops; e++) {
+    switch(plan->ops[e].kind) {
+    case SPRINTF_PLAN_STRING:
+      if (TYPEOF(argp[a++]) != T_STRING) return 0;
+      break;
+    case SPRINTF_PLAN_INT:
+    case SPRINTF_PLAN_HEX:
+      if (TYPEOF(argp[a++]) != T_INT) return 0;
+      break;
+    case SPRINTF_PLAN_CHAR:
+      if ((TYPEOF(argp[a]) != T_INT) || (argp[a].u.integer < 0) ||
+	  (argp[a].u.integer > 0x7fffffff))
+	return 0;
+      a++;
+      break;
+    }
+  }
+
+  for (e = a = 0; e < plan->num_ops; e++) {
+    struct sprintf_plan_op *op = plan->ops + e;
+    switch(op->kind) {
+    case SPRINTF_PLAN_LITERAL:
+      string_builder_append(r, ADD_PCHARP(format, op->start), op->len);
+      break;
+    case SPRINTF_PLAN_STRING:
+      string_builder_shared_strcat(r, argp[a++].u.string);
+      break;
+    case SPRINTF_PLAN_INT:
+      string_builder_append_integer(r, argp[a++].u.integer, 10,
+				    APPEND_SIGNED, 0, 0);
+      break;
+    case SPRINTF_PLAN_HEX:
+      string_builder_append_integer(r, argp[a++].u.integer, 16,
+				    APPEND_SIGNED, 0, 0);
+      break;
+    case SPRINTF_PLAN_CHAR:
+      string_builder_putchar(r, (int)argp[a++].u.integer);
+      break;
+    }
+  }
+  return 1;
+}
+
 /* The efun */
 void low_f_sprintf(INT32 args, struct string_builder *r)
 {
@@ -1935,6 +2077,14 @@ void low_f_sprintf(INT32 args, struct string_builder *r)
     }
   }
 
+  {
+    struct pike_string *format = argp->u.string;
+    struct sprintf_plan *plan =
+      sprintf_plans + ((PTR_TO_INT(format) >> 4) % SPRINTF_PLAN_CACHE_SIZE);
+    if (plan->format != format) compile_sprintf_plan(plan, format);
+    if (run_sprintf_plan(plan, r, argp + 1, args - 1)) return;
+  }
+
   fs.size = round_up32(args*2);
   stack_alloc_init(&fs.a, 128); /* this should scale with fs.size */
   fs.format_info_stack = xalloc(fs.size*sizeof(struct format_info));
@@ -2857,4 +3007,11 @@ void init_sprintf(void)
 
 void exit_sprintf(void)
 {
+  int e;
+  for (e = 0; e < SPRINTF_PLAN_CACHE_SIZE; e++) {
+    if (sprintf_plans[e].format) {
+      free_string(sprintf_plans[e].format);
+      sprintf_plans[e].format = NULL;
+    }
+  }
 }
@@ -697,7 +697,7 @@ static struct pike_string *get_string_slice( void *input, int shift,
                                              ptrdiff_t offset, ptrdiff_t len,
                                              struct pike_string *str )
 {
-    if( !shift && str )
+    if( str )
         return string_slice( str, offset, len );
     return make_shared_binary_pcharp(MKPCHARP(((char *)input)+(offset<<shift),shift),
                                      len);
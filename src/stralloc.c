@@ -49,6 +49,33 @@ static size_t hashkey = 0;
 static unsigned INT32 htable_size=0;
 static struct pike_string **base_table=0;
 static unsigned INT32 num_strings=0;
+
+/* When the table is grown, the old table is kept in old_base_table and
+ * its buckets are moved over to base_table a few at a time by
+ * link_pike_string(), so that no single string creation has to pay
+ * for rehashing the whole table. Buckets below old_table_pos have
+ * already been moved. Code that loops over the whole table calls
+ * finish_string_rehash() first. */
+static struct pike_string **old_base_table=0;
+static unsigned INT32 old_htable_size=0;
+static unsigned INT32 old_table_pos=0;
+
+/* Number of old buckets to move per created string. Anything above
+ * one ensures that the move is done before the table is full again. */
+#define STRING_REHASH_STEP 2
+
+static void finish_string_rehash(void);
+
+/* Returns the bucket that a string with the given hash value belongs
+ * to. */
+static inline struct pike_string **string_bucket(size_t hval)
+{
+  if (UNLIKELY(old_base_table)) {
+    size_t h = hval & (old_htable_size - 1);
+    if (h >= old_table_pos) return old_base_table + h;
+  }
+  return base_table + HMODULO(hval);
+}
 PMOD_EXPORT struct pike_string *empty_pike_string = 0;
 
 /*** Main string hash function ***/
@@ -144,18 +171,25 @@ PMOD_EXPORT void check_string_range( struct pike_string *str,
     {
       case 0:
        {
+         /* NB: Written without conditional jumps in the loop, so
+          *     that the compiler can vectorize it. */
          p_wchar0 *p = (p_wchar0*)str->str;
-         int upper = 0, lower = 0;
-         for( i=0; i<str->len; i++,p++ )
+         unsigned char c_min = 255, c_max = 0, upper = 0, lower = 0;
+         for( i=0; i<str->len; i++ )
          {
+           unsigned char c = p[i];
            /* For 7-bit strings it's easy to check for
             * lower/uppercase, so do that here as well.
             */
-           if( *p >= 'A' && *p <= 'Z') upper++;
-           if( *p >= 'a' && *p <= 'z') lower++;
+           upper |= (unsigned char)(c - 'A') < 26;
+           lower |= (unsigned char)(c - 'a') < 26;
 
-           if( *p > s_max ) s_max = *p;
-           if( *p < s_min ) s_min = *p;
+           c_max = c > c_max ? c : c_max;
+           c_min = c < c_min ? c : c_min;
+         }
+         if( str->len ) {
+           s_min = c_min;
+           s_max = c_max;
          }
 
          if( s_max < 128 )
@@ -173,10 +207,16 @@ PMOD_EXPORT void check_string_range( struct pike_string *str,
       case 1:
        {
          p_wchar1 *p = (p_wchar1*)str->str;
-         for( i=0; i<str->len; i++,p++ )
+         p_wchar1 c_min = 65535, c_max = 0;
+         for( i=0; i<str->len; i++ )
          {
-           if( *p > s_max ) s_max = *p;
-           if( *p < s_min ) s_min = *p;
+           p_wchar1 c = p[i];
+           c_max = c > c_max ? c : c_max;
+           c_min = c < c_min ? c : c_min;
+         }
+         if( str->len ) {
+           s_min = c_min;
+           s_max = c_max;
          }
        }
        str->min = s_min / 256;
@@ -186,10 +226,11 @@ PMOD_EXPORT void check_string_range( struct pike_string *str,
       case 2:
        {
          p_wchar2 *p = (p_wchar2*)str->str;
-         for( i=0; i<str->len; i++,p++ )
+         for( i=0; i<str->len; i++ )
          {
-           if( *p > s_max ) s_max = *p;
-           if( *p < s_min ) s_min = *p;
+           p_wchar2 c = p[i];
+           s_max = c > s_max ? c : s_max;
+           s_min = c < s_min ? c : s_min;
          }
        }
        str->min = (unsigned INT32)s_min / (1 << 24);
@@ -344,6 +385,7 @@ static void locate_problem(int (*isproblem)(const struct pike_string *))
   DM(struct memhdr *yes=alloc_memhdr());
   DM(struct memhdr *no=alloc_memhdr());
 
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     for(s=base_table[e];s;s=s->next)
@@ -400,9 +442,7 @@ static struct pike_string *internal_findstring(const char *s,
   unsigned int depth=0;
   unsigned int prefix_depth=0;
 
-  size_t h;
-  h=HMODULO(hval);
-  for(curr = base_table[h]; curr; curr = curr->next)
+  for(curr = *string_bucket(hval); curr; curr = curr->next)
   {
 #ifdef PIKE_DEBUG
     if(curr->refs<1)
@@ -485,25 +525,44 @@ static void rehash_string_backwards(struct pike_string *s)
   } while ((s = next));
 }
 
-static void stralloc_rehash(void)
+/* Move up to n buckets from the old table to the new one. */
+static void move_old_string_buckets(unsigned INT32 n)
+{
+  while (n-- && (old_table_pos < old_htable_size)) {
+    rehash_string_backwards(old_base_table[old_table_pos]);
+    old_base_table[old_table_pos++] = NULL;
+  }
+  if (old_table_pos >= old_htable_size) {
+    free(old_base_table);
+    old_base_table = NULL;
+    old_htable_size = old_table_pos = 0;
+  }
+}
+
+static void finish_string_rehash(void)
 {
-  int h,old;
-  struct pike_string **old_base;
+  if (old_base_table)
+    move_old_string_buckets(old_htable_size);
+}
 
-  old=htable_size;
-  old_base=base_table;
+static void stralloc_rehash(void)
+{
+  struct pike_string **new_base;
 
-  SET_HSIZE(htable_size<<1);
+  /* The previous resize is normally done long before we get here,
+   * but deletions don't move any buckets. */
+  finish_string_rehash();
 
-  base_table=xcalloc(sizeof(struct pike_string *), htable_size);
+  new_base=xcalloc(sizeof(struct pike_string *), htable_size<<1);
 
-  need_more_hash_prefix_depth = 0;
+  old_base_table=base_table;
+  old_htable_size=htable_size;
+  old_table_pos=0;
 
-  for(h=0;h<old;h++)
-    rehash_string_backwards(old_base[h]);
+  SET_HSIZE(htable_size<<1);
+  base_table=new_base;
 
-  if(old_base)
-    free(old_base);
+  need_more_hash_prefix_depth = 0;
 }
 
 /* Allocation of strings */
@@ -559,6 +618,7 @@ PMOD_EXPORT struct pike_string *debug_begin_shared_string(size_t len)
 
 static void link_pike_string(struct pike_string *s, size_t hval)
 {
+  struct pike_string **bucket;
   size_t h;
 #ifdef PIKE_DEBUG
   if (!(s->flags & STRING_NOT_SHARED)) {
@@ -570,14 +630,16 @@ static void link_pike_string(struct pike_string *s, size_t hval)
     Pike_fatal ("Got undefined contents in pike string %p.\n", s);
 #endif
 
-  h=HMODULO(hval);
-  s->next = base_table[h];
-  base_table[h] = s;
+  bucket = string_bucket(hval);
+  s->next = *bucket;
+  *bucket = s;
   s->hval=hval;
   s->flags &= ~(STRING_NOT_HASHED|STRING_NOT_SHARED);
   num_strings++;
 
-  if(num_strings > htable_size) {
+  if (old_base_table) {
+    move_old_string_buckets(STRING_REHASH_STEP);
+  } else if(num_strings > htable_size) {
     stralloc_rehash();
   }
 
@@ -619,6 +681,7 @@ static void link_pike_string(struct pike_string *s, size_t hval)
      */
     need_more_hash_prefix_depth=0;
 
+    finish_string_rehash();
     for(h=0;h<htable_size;h++)
     {
       struct pike_string *tmp=base_table[h];
@@ -1005,8 +1068,8 @@ PMOD_EXPORT struct pike_string *debug_make_shared_string2(const p_wchar2 *str)
 
 void unlink_pike_string(struct pike_string *s)
 {
-  size_t h=HMODULO(s->hval);
-  struct pike_string *tmp=base_table[h], *p=NULL;
+  struct pike_string **bucket = string_bucket(s->hval);
+  struct pike_string *tmp=*bucket, *p=NULL;
 
   while( tmp )
   {
@@ -1015,7 +1078,7 @@ void unlink_pike_string(struct pike_string *s)
       if( p )
         p->next = s->next;
       else
-        base_table[h] = s->next;
+        *bucket = s->next;
       break;
     }
     p = tmp;
@@ -1102,6 +1165,7 @@ struct pike_string *add_string_status(int verbose)
     long overhead_bytes[8] = {0,0,0,0,0,0,0,0};
     unsigned INT32 e;
     struct pike_string *p;
+    finish_string_rehash();
     for(e=0;e<htable_size;e++)
     {
       for(p=base_table[e];p;p=p->next)
@@ -1254,6 +1318,7 @@ PMOD_EXPORT void verify_shared_strings_tables(void)
 
   last_stralloc_verify=current_do_debug_cycle;
 
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     h=0;
@@ -1314,12 +1379,10 @@ PMOD_EXPORT void verify_shared_strings_tables(void)
  */
 const struct pike_string *debug_findstring(const struct pike_string *s)
 {
-  size_t h;
   struct pike_string *p;
 
   if(!base_table) return NULL;
-  h = HMODULO(s->hval);
-  for(p=base_table[h];p;p=p->next)
+  for(p=*string_bucket(s->hval);p;p=p->next)
   {
     if(p==s)
     {
@@ -1333,6 +1396,7 @@ int safe_debug_findstring(const struct pike_string *foo)
 {
   unsigned INT32 e;
   if(!base_table) return 0;
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     struct pike_string *p;
@@ -1389,6 +1453,7 @@ void dump_stralloc_strings(void)
 {
   unsigned INT32 e;
   struct pike_string *p;
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     for(p=base_table[e];p;p=p->next) {
@@ -2115,6 +2180,7 @@ void cleanup_shared_string_table(void)
   }
 #endif
 
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     for(s=base_table[e];s;s=next)
@@ -2137,6 +2203,7 @@ void count_string_types() {
   unsigned INT32 e;
   size_t num_static = 0, num_short = 0, num_substring = 0, num_malloc = 0;
 
+  finish_string_rehash();
   for (e = 0; e < htable_size; e++) {
       struct pike_string * s;
 
@@ -2193,6 +2260,8 @@ void count_memory_in_strings(size_t *num, size_t *_size)
   size_t size = 0;
   *num = num_strings;
 
+  finish_string_rehash();
+
   size+=htable_size * sizeof(struct pike_string *);
 
   for (e = 0; e < htable_size; e++) {
@@ -2230,6 +2299,7 @@ unsigned gc_touch_all_strings(void)
   unsigned INT32 e;
   unsigned n = 0;
   if (!base_table) return 0;
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     struct pike_string *p;
@@ -2242,6 +2312,7 @@ void gc_mark_all_strings(void)
 {
   unsigned INT32 e;
   if(!base_table) return;
+  finish_string_rehash();
   for(e=0;e<htable_size;e++)
   {
     struct pike_string *p;
@@ -2255,6 +2326,7 @@ PMOD_EXPORT struct pike_string *next_pike_string (const struct pike_string *s)
   struct pike_string *next = s->next;
   if (!next) {
     size_t h = s->hval;
+    finish_string_rehash();
     do {
       h++;
       h = HMODULO(h);
@@ -402,6 +402,16 @@ static int live_threads = 0;
 static COND_T live_threads_change;
 static COND_T threads_disabled_change;
 
+/* Threads that want the interpreter lock. iplock_wanted is only
+ * modified while holding interpreter_lock_wanted, so it's at most one
+ * (see pike_low_lock_interpreter). iplock_cond_waiters counts the
+ * threads sleeping on a condition variable tied to the interpreter
+ * lock, and is only modified while holding the interpreter lock.
+ * check_threads() uses them to skip the lock handoff when there's
+ * nobody to hand the lock to. */
+static volatile int iplock_wanted = 0;
+static int iplock_cond_waiters = 0;
+
 struct thread_local_var
 {
   INT32 id;
@@ -459,7 +469,9 @@ PMOD_EXPORT void pike_low_lock_interpreter (DLOC_DECL)
    * we ensure a thread switch in check_threads, if there are other
    * threads waiting. */
   mt_lock (&interpreter_lock_wanted);
+  iplock_wanted++;
   mt_lock (&interpreter_lock);
+  iplock_wanted--;
   mt_unlock (&interpreter_lock_wanted);
 
   SET_LOCKING_THREAD;
@@ -477,7 +489,9 @@ PMOD_EXPORT void pike_low_wait_interpreter (COND_T *cond COMMA_DLOC_DECL)
   /* FIXME: Should use interpreter_lock_wanted here as well. The
    * problem is that few (if any) thread libs lets us atomically
    * unlock a mutex and wait, and then lock a different mutex. */
+  iplock_cond_waiters++;
   co_wait (cond, &interpreter_lock);
+  iplock_cond_waiters--;
 
   SET_LOCKING_THREAD;
   THREADS_FPRINTF (1, "Got signal on cond %p with iplock @ %s:%d\n",
@@ -497,7 +511,9 @@ PMOD_EXPORT int pike_low_timedwait_interpreter (COND_T *cond,
   /* FIXME: Should use interpreter_lock_wanted here as well. The
    * problem is that few (if any) thread libs lets us atomically
    * unlock a mutex and wait, and then lock a different mutex. */
+  iplock_cond_waiters++;
   res = co_wait_timeout (cond, &interpreter_lock, sec, nsec);
+  iplock_cond_waiters--;
 
   SET_LOCKING_THREAD;
   THREADS_FPRINTF (1, "Got signal on cond %p with iplock @ %s:%d\n",
@@ -513,7 +529,9 @@ static void threads_disabled_wait (DLOC_DECL)
     THREADS_FPRINTF (1, "Waiting on threads_disabled @ %s:%d\n",
                      DLOC_ARGS_OPT);
     UNSET_LOCKING_THREAD;
+    iplock_cond_waiters++;
     co_wait (&threads_disabled_change, &interpreter_lock);
+    iplock_cond_waiters--;
     SET_LOCKING_THREAD;
   } while (threads_disabled);
   THREADS_FPRINTF (1, "Continue after threads_disabled @ %s:%d\n",
@@ -1356,6 +1374,22 @@ union pike_hrtime {
 };
 #endif
 
+static void start_new_time_slice(void)
+{
+#ifdef USE_CLOCK_FOR_SLICES
+  thread_start_clock = clock();
+#ifdef RDTSC
+  RDTSC (prev_tsc);
+  prev_clock = thread_start_clock;
+#endif
+#ifdef PIKE_DEBUG
+  if (last_clocked_thread != th_self())
+    Pike_fatal ("Stale thread %08lx in last_clocked_thread (self is %08lx)\n",
+		(unsigned long) last_clocked_thread, (unsigned long) th_self());
+#endif
+#endif
+}
+
 static void check_threads(struct callback *UNUSED(cb), void *UNUSED(arg), void *UNUSED(arg2))
 {
 #ifdef PROFILE_CHECK_THREADS
@@ -1581,6 +1615,24 @@ static void check_threads(struct callback *UNUSED(cb), void *UNUSED(arg), void *
 #endif
 
   do_yield:;
+  if (!iplock_wanted && !iplock_cond_waiters) {
+    /* No other thread is waiting for the interpreter lock, so
+     * releasing it would only cost us a pair of mutex operations and
+     * a pointless sched_yield(). Just start a new time slice.
+     *
+     * Condition waiters must force the handoff even though most of
+     * them are just sleeping: a waiter that has been signalled
+     * reacquires interpreter_lock directly in co_wait(), without
+     * going through interpreter_lock_wanted, so iplock_wanted never
+     * counts it. There's no way to tell it apart from the sleeping
+     * ones, and skipping the handoff would starve it for as long as
+     * we keep running, eg a Thread.Queue reader behind a writer
+     * that's busy computing. So the skip only applies when no thread
+     * is waiting on a condition. */
+    start_new_time_slice();
+    return;
+  }
+
 #ifdef PIKE_DEBUG
   check_threads_yields++;
 #endif
@@ -1633,21 +1685,10 @@ PMOD_EXPORT void pike_thread_yield(void)
   th_yield();
   THREADS_DISALLOW();
 
-#ifdef USE_CLOCK_FOR_SLICES
   /* If we didn't yield then give ourselves a new time slice. If we
    * did yield then thread_start_clock is the current clock anyway
    * after the thread swap in. */
-  thread_start_clock = clock();
-#ifdef RDTSC
-  RDTSC (prev_tsc);
-  prev_clock = thread_start_clock;
-#endif
-#ifdef PIKE_DEBUG
-  if (last_clocked_thread != th_self())
-    Pike_fatal ("Stale thread %08lx in last_clocked_thread (self is %08lx)\n",
-		(unsigned long) last_clocked_thread, (unsigned long) th_self());
-#endif
-#endif
+  start_new_time_slice();
 
   DEBUG_CHECK_THREAD();
 }